@@ -0,0 +1,55 @@
+#include "ExportQueue.hpp"
+
+ExportQueue::ExportQueue() : worker([this] { run(); }) {}
+
+ExportQueue::~ExportQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobs_changed.notify_one();
+  worker.join();
+}
+
+void ExportQueue::save(const QImage &image, const QString &filename) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back({image, filename, quality});
+  }
+  jobs_changed.notify_one();
+}
+
+void ExportQueue::save(const QImage &image, const QString &filename, int q) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back({image, filename, q});
+  }
+  jobs_changed.notify_one();
+}
+
+void ExportQueue::setQuality(int q) {
+  std::lock_guard<std::mutex> lock(mutex);
+  quality = q;
+}
+
+void ExportQueue::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    jobs_changed.wait(lock, [&] { return stopping || !jobs.empty(); });
+
+    // Drain the queue even when stopping, so that closing the window does
+    // not lose a save that the user has asked for.
+    if (jobs.empty())
+      return;
+
+    auto job = std::move(jobs.front());
+    jobs.pop_front();
+    lock.unlock();
+
+    bool ok = job.image.save(job.filename, "png", job.quality);
+    job.image = {}; // Release the pixels before waiting for the next job
+    saved(job.filename, ok);
+
+    lock.lock();
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QImage>
+#include <QObject>
+#include <QString>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Saves images on a background thread, so that the user can carry on
+// navigating whilst large images are being encoded.
+class ExportQueue : public QObject {
+  Q_OBJECT
+public:
+  ExportQueue();
+  ~ExportQueue(); // Waits for pending saves to finish
+
+  // QImage is implicitly shared, so this only takes a reference to the pixels.
+  // The caller's image is copied if it is modified before the save completes.
+  void save(const QImage &image, const QString &filename);
+  void save(const QImage &image, const QString &filename, int quality);
+
+  // Passed to QImage::save(). For PNG, 0 is the smallest file and 100 is the
+  // fastest. -1 uses the default compression.
+  void setQuality(int quality);
+
+signals:
+  // Emitted on the worker thread, so connections are queued.
+  void saved(const QString &filename, bool ok);
+
+private:
+  struct Job {
+    QImage image;
+    QString filename;
+    int quality;
+  };
+
+  void run();
+
+  std::mutex mutex;
+  std::condition_variable jobs_changed;
+  std::deque<Job> jobs;
+  int quality = -1;
+  bool stopping = false;
+  std::thread worker;
+};
@@ -0,0 +1,140 @@
+#include "MetricsLog.hpp"
+#include "nlohmann/json.hpp"
+
+#include <QSettings>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+const std::uintmax_t max_log_size = 16 * 1024 * 1024;
+const int max_log_files = 5;
+
+// -1 if not available on this platform
+long resident_bytes() {
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  long size, resident;
+  if (statm >> size >> resident)
+    return resident * sysconf(_SC_PAGESIZE);
+#endif
+  return -1;
+}
+
+std::filesystem::path log_file(const std::filesystem::path &directory, int n) {
+  if (n == 0)
+    return directory / "metrics.jsonl";
+  return directory / ("metrics." + std::to_string(n) + ".jsonl");
+}
+} // namespace
+
+MetricsLog::MetricsLog(const std::filesystem::path &directory)
+    : directory(directory), last_write(std::chrono::steady_clock::now()) {
+  connect(&timer, &QTimer::timeout, this, &MetricsLog::write);
+
+  QSettings settings(settingsFilename(), QSettings::IniFormat);
+  if (settings.value("LogMetrics", false).toBool())
+    timer.start(std::chrono::minutes(1));
+}
+
+QString MetricsLog::settingsFilename() const {
+  return QString::fromStdString((directory / "settings.ini").string());
+}
+
+bool MetricsLog::isEnabled() const { return timer.isActive(); }
+
+void MetricsLog::setEnabled(bool enabled) {
+  if (enabled == isEnabled())
+    return;
+
+  if (enabled) {
+    frames = 0;
+    last_write = std::chrono::steady_clock::now();
+    timer.start(std::chrono::minutes(1));
+  } else {
+    timer.stop();
+  }
+
+  QSettings settings(settingsFilename(), QSettings::IniFormat);
+  settings.setValue("LogMetrics", enabled);
+  enabledChanged(enabled);
+}
+
+void MetricsLog::record(const fractals::calculation_metrics &metrics) {
+  if (!isEnabled())
+    return;
+
+  ++frames;
+
+  std::stringstream ss;
+  ss << std::setprecision(2) << metrics.radius;
+  radius = ss.str();
+
+  render_time_seconds = metrics.render_time_seconds;
+  min_depth = metrics.min_depth;
+  max_depth = metrics.max_depth;
+  discovered_depth = metrics.discovered_depth;
+  points_calculated = metrics.points_calculated;
+  average_iterations = metrics.average_iterations;
+  average_skipped_iterations = metrics.average_skipped_iterations;
+}
+
+void MetricsLog::write() {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - last_write;
+  double frames_per_minute =
+      elapsed.count() > 0 ? frames * 60.0 / elapsed.count() : 0;
+  last_write = now;
+  frames = 0;
+
+  nlohmann::json js = {};
+  js["Time"] = std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+  js["FramesPerMinute"] = frames_per_minute;
+  js["ResidentBytes"] = resident_bytes();
+  js["Radius"] = radius;
+  js["RenderTimeSeconds"] = render_time_seconds;
+  js["MinDepth"] = min_depth;
+  js["MaxDepth"] = max_depth;
+  js["DiscoveredDepth"] = discovered_depth;
+  js["PointsCalculated"] = points_calculated;
+  js["AverageIterations"] = average_iterations;
+  js["AverageSkippedIterations"] = average_skipped_iterations;
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+
+  rotate();
+  std::ofstream(log_file(directory, 0), std::ios::app) << js.dump() << "\n";
+
+  // Replace the text file in one step so that readers never see half of it
+  auto text_file = directory / "metrics.txt";
+  auto temp_file = directory / "metrics.txt.tmp";
+  {
+    std::ofstream text(temp_file);
+    for (auto &[key, value] : js.items()) {
+      if (value.is_number())
+        text << key << " " << value.dump() << "\n";
+    }
+  }
+  std::filesystem::rename(temp_file, text_file, ec);
+}
+
+void MetricsLog::rotate() {
+  std::error_code ec;
+  auto current = log_file(directory, 0);
+  auto size = std::filesystem::file_size(current, ec);
+  if (ec || size < max_log_size)
+    return;
+
+  std::filesystem::remove(log_file(directory, max_log_files - 1), ec);
+  for (int n = max_log_files - 2; n >= 0; --n)
+    std::filesystem::rename(log_file(directory, n), log_file(directory, n + 1),
+                            ec);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "calculation_metrics.hpp"
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+// Periodically writes the latest calculation metrics together with
+// process-level figures, so that long unattended sessions can be monitored.
+//
+// Each write() appends one line to metrics.jsonl (rotated by size), and
+// replaces metrics.txt with one "name value" pair per line for collectors
+// that read a text file.
+//
+// There is one MetricsLog for the whole app, shared by all windows, so that
+// only one owner writes and rotates the files. Whether it is enabled is
+// remembered between sessions.
+class MetricsLog : public QObject {
+  Q_OBJECT
+public:
+  explicit MetricsLog(const std::filesystem::path &directory);
+
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  // Call for each completed calculation, from any window
+  void record(const fractals::calculation_metrics &metrics);
+
+public slots:
+  void write();
+
+signals:
+  void enabledChanged(bool enabled);
+
+private:
+  void rotate();
+  QString settingsFilename() const;
+
+  std::filesystem::path directory;
+  QTimer timer;
+  std::chrono::steady_clock::time_point last_write;
+  int frames = 0;
+
+  // From the most recent calculation
+  std::string radius;
+  double render_time_seconds = 0;
+  double min_depth = 0, max_depth = 0, discovered_depth = 0;
+  double points_calculated = 0;
+  double average_iterations = 0, average_skipped_iterations = 0;
+};
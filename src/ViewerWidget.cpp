@@ -2,6 +2,7 @@
 
 #include <QApplication>
 #include <QClipboard>
+#include <QDir>
 #include <QFileDialog>
 #include <QImage>
 #include <QMimeData>
@@ -19,6 +20,7 @@
 #include "nlohmann/json.hpp"
 #include "view_parameters.hpp"
 
+#include <cmath>
 #include <filesystem>
 #include <iomanip>
 #include <iostream>
@@ -40,8 +42,11 @@ ViewerWidget::ViewerWidget(QWidget *parent)
           &ViewerWidget::shadingParametersChanged);
   connect(&controlPanel, &ControlPanel::rescalePalette, this,
           &ViewerWidget::scalePalette);
+  connect(&exportQueue, &ExportQueue::saved, this, &ViewerWidget::saved);
 }
 
+ViewerWidget::~ViewerWidget() { saveSession(); }
+
 void ViewerWidget::paintEvent(QPaintEvent *event) { draw(); }
 
 void ViewerWidget::calculate() {
@@ -52,35 +57,69 @@ void ViewerWidget::calculate() {
   renderer.calculate_async();
 }
 
+void ViewerWidget::updateGradients() {
+  auto &values = renderer.view.values();
+  int w = image.width(), h = image.height();
+  gradients.resize(w * h);
+  gradients_width = w;
+  gradients_height = h;
+
+  for (int j = 0; j < h; ++j) {
+    for (int i = 0; i < w; ++i) {
+      double v = values(i, j).value;
+      float dx =
+          i + 1 < w ? values(i + 1, j).value - v : v - values(i - 1, j).value;
+      float dy =
+          j + 1 < h ? values(i, j + 1).value - v : v - values(i, j - 1).value;
+      gradients[j * w + i] = {dx, dy};
+    }
+  }
+}
+
 void ViewerWidget::draw() {
   pending_redraw = 0;
   QPainter painter(this);
 
+  if (firstFrameMilliseconds < 0 && startupTimer.isValid())
+    firstFrameMilliseconds = startupTimer.elapsed();
+
+  if (showCachedFrame && cachedFrameIsCurrent()) {
+    // Draw it into the image so that save and copy get what is on screen
+    QPainter(&image).drawImage(image.rect(), cachedFrame);
+    painter.drawImage(this->rect(), image);
+    return;
+  }
+
+  // Release the cached frame here rather than in calculation_finished(),
+  // which is called on a different thread.
+  showCachedFrame = false;
+  if (!cachedFrame.isNull())
+    cachedFrame = {};
+
   auto &colourMap = *renderer.colourMap;
 
   std::uint32_t *image_data = (std::uint32_t *)image.bits();
   auto &values = renderer.view.values();
   bool render_shadows = renderer.fully_calculated();
-
-  for (int j = 0; j < image.height(); ++j) {
-    for (int i = 0; i < image.width(); ++i) {
-      int delta = 1;
-      auto &pixel = values(i, j);
-      auto &p2 = i + delta < image.width() ? values(i + delta, j)
-                                           : values(i - delta, j);
-      auto &p3 = j + delta < image.height()
-                     ? values(i, j + delta)
-                     : values(i, j - delta);
-      if (render_shadows) {
-        double dx = i + delta < image.width()
-                        ? p2.value - values(i, j).value
-                        : values(i, j).value - p2.value;
-        double dy = j + delta < image.height()
-                        ? p3.value - values(i, j).value
-                        : values(i, j).value - p3.value;
+  imageIsFinished = render_shadows;
+
+  if (render_shadows) {
+    // Only recalculate the gradients if the values have changed, not when
+    // just the lighting has changed.
+    if (gradients_dirty.exchange(false) || gradients_width != image.width() ||
+        gradients_height != image.height())
+      updateGradients();
+
+    for (int j = 0; j < image.height(); ++j) {
+      for (int i = 0; i < image.width(); ++i) {
+        auto &[dx, dy] = gradients[j * image.width() + i];
         image_data[j * image.width() + i] =
-            0xff000000 | colourMap(pixel.value, dx, dy);
-      } else {
+            0xff000000 | colourMap(values(i, j).value, dx, dy);
+      }
+    }
+  } else {
+    for (int j = 0; j < image.height(); ++j) {
+      for (int i = 0; i < image.width(); ++i) {
         image_data[j * image.width() + i] =
             0xff000000 | colourMap(values(i, j).value);
       }
@@ -209,6 +248,7 @@ void ViewerWidget::doUpdate() {
 
 void ViewerWidget::values_changed() {
   // Note will be called on different threads
+  gradients_dirty = true;
   if (!pending_redraw) {
     ++pending_redraw;
     doUpdate();
@@ -224,8 +264,11 @@ void ViewerWidget::calculation_finished(
 
   renderer.update_iterations(metrics);
 
-  if (metrics.fully_evaluated)
+  if (metrics.fully_evaluated) {
+    if (showCachedFrame.exchange(false))
+      doUpdate();
     completed(&metrics);
+  }
 }
 
 void ViewerWidget::increaseIterations() {
@@ -322,14 +365,26 @@ void ViewerWidget::quickSave() {
     auto prefix = "fractal ";
     std::filesystem::path image_filename;
 
-    for (int file_counter = 0; file_counter < 1000; ++file_counter) {
+    // Carry on from the previous quick save, so that we don't probe the same
+    // files again, and don't reuse the name of a save that is still pending.
+    for (; quickSaveCounter < 1000; ++quickSaveCounter) {
       std::stringstream ss;
       ss << (desktop / prefix).string();
-      ss << file_counter << ".png";
-      image_filename = ss.str();
-      if (!std::filesystem::exists(image_filename))
+      ss << quickSaveCounter << ".png";
+      if (!std::filesystem::exists(ss.str())) {
+        image_filename = ss.str();
         break;
+      }
+    }
+
+    if (image_filename.empty()) {
+      // All names are taken. Probe again from the start next time, in case
+      // files have been removed in the meantime.
+      quickSaveCounter = 0;
+      saved(((desktop / prefix).string() + "*.png").c_str(), false);
+      return;
     }
+    ++quickSaveCounter;
 
     // Update the image metadata
     saveToFile((image_filename).string().c_str());
@@ -342,7 +397,10 @@ void ViewerWidget::saveToFile(const QString &image_filename) {
   renderer.colourMap->save(params);
 
   image.setText("MandelbrotQtjson", write_json(params).dump().c_str());
-  image.save(image_filename, "png");
+
+  // Encoded in the background. The next draw() will copy the image rather
+  // than modify the one being saved.
+  exportQueue.save(image, image_filename);
 }
 
 void ViewerWidget::scalePalette() {
@@ -439,6 +497,12 @@ void ViewerWidget::setFastestAnimation() {
   renderer.set_animation_speed(50ms, true);
 }
 
+void ViewerWidget::setFastCompression() { exportQueue.setQuality(100); }
+
+void ViewerWidget::setDefaultCompression() { exportQueue.setQuality(-1); }
+
+void ViewerWidget::setBestCompression() { exportQueue.setQuality(0); }
+
 void ViewerWidget::enableOversampling(bool checked) {
   QResizeEvent s(size(), size());
   imageScale = checked ? 2.0 : 1.0;
@@ -502,3 +566,95 @@ void ViewerWidget::showOrbits(bool checked) {
 
   QWidget::update();
 }
+
+QString ViewerWidget::sessionFilename() const {
+  auto dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  if (dir.isEmpty() || !QDir().mkpath(dir))
+    return {};
+  return dir + "/last view.png";
+}
+
+void ViewerWidget::saveSession() {
+  // Only replace the previous session with a finished image. If the image
+  // has not been drawn yet, or is still being calculated, keep the old file.
+  if (showCachedFrame || !imageIsFinished || !renderer.fully_calculated())
+    return;
+
+  auto filename = sessionFilename();
+  if (image.isNull() || filename.isEmpty())
+    return;
+
+  fractals::view_parameters params;
+  getCoords(params);
+
+  // Save at window size with the default compression, to keep the file
+  // small and quick to load at startup. Finished by ~ExportQueue.
+  auto frame = image.scaled(size(), Qt::IgnoreAspectRatio,
+                            Qt::SmoothTransformation);
+  frame.setText("MandelbrotQtjson", write_json(params).dump().c_str());
+  exportQueue.save(frame, filename, -1);
+}
+
+bool ViewerWidget::restoreSession() {
+  auto filename = sessionFilename();
+  QImage frame;
+  if (filename.isEmpty() || !frame.load(filename))
+    return false;
+
+  auto text = frame.text("MandelbrotQtjson");
+  if (text.isEmpty())
+    return false;
+  auto js = nlohmann::json::parse(text.toStdString(), nullptr, false);
+  if (js.is_discarded())
+    return false;
+  auto params = read_json(js);
+
+  renderer.load(params);
+  fractalChanged(renderer.fractal_name().c_str()); // Update menus if needed
+  controlPanel.valuesChanged(&params.shader);
+
+  // Compare against the coords as the renderer writes them, not as loaded
+  renderer.save(cachedFrameParams);
+  renderer.colourMap->getParameters(cachedFrameShader);
+  cachedFrame = std::move(frame);
+  showCachedFrame = true;
+  QWidget::update();
+  return true;
+}
+
+bool ViewerWidget::cachedFrameIsCurrent() const {
+  if (image.isNull() || cachedFrame.isNull())
+    return false;
+
+  // Don't stretch the frame to a different shape
+  double aspect = double(image.width()) / image.height();
+  double cachedAspect = double(cachedFrame.width()) / cachedFrame.height();
+  if (std::abs(aspect - cachedAspect) > 0.01 * aspect)
+    return false;
+
+  fractals::view_parameters params;
+  renderer.save(params);
+  if (params.x != cachedFrameParams.x || params.y != cachedFrameParams.y ||
+      params.r != cachedFrameParams.r ||
+      params.algorithm != cachedFrameParams.algorithm)
+    return false;
+
+  fractals::shader_parameters shader;
+  renderer.colourMap->getParameters(shader);
+  return shader.colour_scheme == cachedFrameShader.colour_scheme &&
+         shader.colour_gradient == cachedFrameShader.colour_gradient &&
+         shader.colour_offset == cachedFrameShader.colour_offset &&
+         shader.shading == cachedFrameShader.shading &&
+         shader.ambient_brightness == cachedFrameShader.ambient_brightness &&
+         shader.source_brightness == cachedFrameShader.source_brightness &&
+         shader.source_direction_radians ==
+             cachedFrameShader.source_direction_radians &&
+         shader.source_elevation_radians ==
+             cachedFrameShader.source_elevation_radians;
+}
+
+void ViewerWidget::setStartupTimer(const QElapsedTimer &timer) {
+  startupTimer = timer;
+}
+
+qint64 ViewerWidget::timeToFirstFrame() const { return firstFrameMilliseconds; }
@@ -1,16 +1,19 @@
 #ifndef VIEWERWIDGET_H
 #define VIEWERWIDGET_H
 
+#include <QElapsedTimer>
 #include <QImage>
 #include <QTimer>
 #include <QWidget>
 
 #include "AnimatedRenderer.hpp"
+#include "ExportQueue.hpp"
 #include "shader.hpp"
 #include "controlpanel.h"
 #include "fractal.hpp"
 #include "registry.hpp"
 #include "view_coords.hpp"
+#include "view_parameters.hpp"
 
 class ViewerWidget : public QWidget, fractals::view_listener {
   Q_OBJECT
@@ -31,16 +34,54 @@ class ViewerWidget : public QWidget, fractals::view_listener {
   void calculate();
   void draw();
 
+  // The shading gradient (dx, dy) of each pixel, cached so that changing the
+  // lighting does not need to recompute it. Invalidated by values_changed().
+  std::vector<std::pair<float, float>> gradients;
+  int gradients_width = 0, gradients_height = 0;
+  std::atomic<bool> gradients_dirty = true;
+  void updateGradients();
+
   std::atomic<int> pending_redraw;
 
   ControlPanel controlPanel;
   void doUpdate();
 
+  ExportQueue exportQueue;
+  // Shared by all windows, so that quick saves still being encoded by another
+  // window's queue do not get the same name.
+  inline static int quickSaveCounter = 0;
+
+  // The image from the end of the previous session, shown at startup until
+  // the first calculation completes or the view moves.
+  QImage cachedFrame;
+  fractals::view_parameters cachedFrameParams;
+  fractals::shader_parameters cachedFrameShader;
+  std::atomic<bool> showCachedFrame = false;
+  bool cachedFrameIsCurrent() const;
+  QString sessionFilename() const;
+
+  // Whether the last draw() was of a fully calculated image
+  bool imageIsFinished = false;
+
+  QElapsedTimer startupTimer;
+  qint64 firstFrameMilliseconds = -1;
+
   bool show_orbits = false;
   fractals::displayed_orbit current_orbit;
 
 public:
   explicit ViewerWidget(QWidget *parent = nullptr);
+  ~ViewerWidget();
+
+  // Resume the view (and its image) from when the app last closed
+  bool restoreSession();
+  void saveSession();
+
+  // Started when the process started. Only set for the first window.
+  void setStartupTimer(const QElapsedTimer &timer);
+
+  // -1 if nothing has been drawn yet, or there is no startup timer
+  qint64 timeToFirstFrame() const;
 
   void paintEvent(QPaintEvent *event) override;
   void resizeEvent(QResizeEvent *event) override;
@@ -102,6 +143,10 @@ public slots:
   void setFastAnimation();
   void setFastestAnimation();
 
+  void setFastCompression();
+  void setDefaultCompression();
+  void setBestCompression();
+
   void openBookmark(const fractals::view_parameters *params);
   void showOptions();
 
@@ -116,6 +161,7 @@ signals:
   void renderingFinishedSignal();
   void fractalChanged(const char *name);
   void shadingChanged(bool);
+  void saved(const QString &filename, bool ok);
 };
 
 #endif // VIEWERWIDGET_H
@@ -1,12 +1,34 @@
+#include "MetricsLog.hpp"
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStandardPaths>
 
 int main(int argc, char *argv[])
 {
+  QElapsedTimer startupTimer;
+  startupTimer.start();
+
   fclose(stderr); // Get rid of unacceptable Apple stderr noise
   QApplication a(argc, argv);
-  MainWindow w;
+
+  QCommandLineParser parser;
+  QCommandLineOption logMetrics("log-metrics",
+                                "Write metrics for unattended sessions.");
+  parser.addOption(logMetrics);
+  parser.parse(a.arguments()); // Ignore unknown platform arguments
+
+  // Shared by all windows
+  auto metricsLog = std::make_shared<MetricsLog>(
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+          .toStdString());
+  if (parser.isSet(logMetrics))
+    metricsLog->setEnabled(true);
+
+  MainWindow w(metricsLog);
+  w.setStartupTimer(startupTimer);
   w.show();
   return a.exec();
 }
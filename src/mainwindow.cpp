@@ -11,11 +11,13 @@
 #include <nlohmann/json.hpp>
 #include <sstream>
 
-MainWindow::MainWindow(const std::shared_ptr<SharedBookmarks> &bookmarks0,
+MainWindow::MainWindow(const std::shared_ptr<MetricsLog> &metricsLog0,
+                       const std::shared_ptr<SharedBookmarks> &bookmarks0,
                        QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow), bookmarks(bookmarks0),
       fractalsActionGroup(this), zoomSpeedActionGroup(this),
-      threadingActionGroup(this) {
+      threadingActionGroup(this), compressionActionGroup(this),
+      metricsLog(metricsLog0) {
   ui->setupUi(this);
   connect(ui->centralwidget, &ViewerWidget::startCalculating, this,
           &MainWindow::startCalculating);
@@ -94,6 +96,18 @@ MainWindow::MainWindow(const std::shared_ptr<SharedBookmarks> &bookmarks0,
           &MainWindow::shadingChanged);
   connect(ui->actionShow_orbits, &QAction::triggered, ui->centralwidget,
           &ViewerWidget::showOrbits);
+  connect(ui->actionFast_compression, &QAction::triggered, ui->centralwidget,
+          &ViewerWidget::setFastCompression);
+  connect(ui->actionDefault_compression, &QAction::triggered,
+          ui->centralwidget, &ViewerWidget::setDefaultCompression);
+  connect(ui->actionBest_compression, &QAction::triggered, ui->centralwidget,
+          &ViewerWidget::setBestCompression);
+  connect(ui->centralwidget, &ViewerWidget::saved, this, &MainWindow::saved);
+  ui->actionLog_metrics->setChecked(metricsLog->isEnabled());
+  connect(ui->actionLog_metrics, &QAction::triggered, metricsLog.get(),
+          &MetricsLog::setEnabled);
+  connect(metricsLog.get(), &MetricsLog::enabledChanged,
+          ui->actionLog_metrics, &QAction::setChecked);
 
   connect(ui->menuBookmarks_2, &QMenu::aboutToShow, this,
           &MainWindow::reloadBookmarks);
@@ -110,20 +124,22 @@ MainWindow::MainWindow(const std::shared_ptr<SharedBookmarks> &bookmarks0,
   threadingActionGroup.addAction(ui->actionMax_threads);
   threadingActionGroup.addAction(ui->actionSingle_threaded);
 
+  compressionActionGroup.setExclusionPolicy(
+      QActionGroup::ExclusionPolicy::Exclusive);
+  compressionActionGroup.addAction(ui->actionFast_compression);
+  compressionActionGroup.addAction(ui->actionDefault_compression);
+  compressionActionGroup.addAction(ui->actionBest_compression);
+
   QIcon icon(":/new/prefix1/icon.ico");
   QApplication::setWindowIcon(icon);
 
   initialBookmarksMenuSize = ui->menuBookmarks_2->actions().size();
 
-  if (!bookmarks) {
+  // Bookmarks are loaded when the menu is first opened, to keep them off
+  // the startup path.
+  bool firstWindow = !bookmarks;
+  if (firstWindow)
     bookmarks = std::make_shared<SharedBookmarks>();
-    loadBookmarks(QFile(":/new/prefix1/bookmarks.json"), false, true);
-    loadBookmarks(getBookmarksFile(), true, false);
-  } else {
-    loadBookmarks(QFile(":/new/prefix1/bookmarks.json"), false, false);
-    for (auto &bm : bookmarks->userAddedBookmarks)
-      addBookmarkToList(bm, false, false);
-  }
 
   fractalsActionGroup.setExclusionPolicy(
       QActionGroup::ExclusionPolicy::Exclusive);
@@ -138,10 +154,17 @@ MainWindow::MainWindow(const std::shared_ptr<SharedBookmarks> &bookmarks0,
     ui->menuFractal->addAction(action);
     fractalsActionGroup.addAction(action);
   }
+
+  if (firstWindow)
+    ui->centralwidget->restoreSession();
 }
 
 MainWindow::~MainWindow() { delete ui; }
 
+void MainWindow::setStartupTimer(const QElapsedTimer &timer) {
+  ui->centralwidget->setStartupTimer(timer);
+}
+
 void MainWindow::changeFractal(ChangeFractalAction *src,
                                const fractals::fractal &fractal) {
   ui->centralwidget->changeFractal(fractal);
@@ -158,6 +181,8 @@ void MainWindow::startCalculating(numbers::radius d, int iterations) {
 }
 
 void MainWindow::completed(const fractals::calculation_metrics *metrics) {
+  metricsLog->record(*metrics);
+
   std::stringstream ss;
 #ifndef NDEBUG
   ss << "DEBUG BUILD ";
@@ -173,6 +198,13 @@ void MainWindow::completed(const fractals::calculation_metrics *metrics) {
        << (100.0 * metrics->average_skipped_iterations /
            metrics->average_iterations)
        << "%)";
+
+    // Only of interest once, at startup
+    if (!firstFrameReported && ui->centralwidget->timeToFirstFrame() >= 0) {
+      firstFrameReported = true;
+      ss << ", first frame after " << ui->centralwidget->timeToFirstFrame()
+         << "ms";
+    }
   }
 
   ui->statusbar->showMessage(ss.str().c_str());
@@ -261,6 +293,8 @@ void MainWindow::addBookmarkToList(const fractals::view_parameters &params,
 void MainWindow::addBookmark() {
   AddBookmark dialog;
   if (dialog.exec()) {
+    // Don't overwrite bookmarks.json with only the new bookmark
+    loadBookmarksIfNeeded();
     fractals::view_parameters params;
     ui->centralwidget->getCoords(params);
     params.title = dialog.getName().toStdString();
@@ -283,6 +317,14 @@ void MainWindow::loadBookmarks(QFile &&file, bool isUser, bool isBuiltin) {
   }
 }
 
+void MainWindow::loadBookmarksIfNeeded() {
+  if (bookmarks->loaded)
+    return;
+  bookmarks->loaded = true;
+  loadBookmarks(QFile(":/new/prefix1/bookmarks.json"), false, true);
+  loadBookmarks(getBookmarksFile(), true, false);
+}
+
 QFile MainWindow::getBookmarksFile() { return QFile("bookmarks.json"); }
 
 void MainWindow::saveBookmarks() {
@@ -298,7 +340,7 @@ void MainWindow::saveBookmarks() {
 }
 
 void MainWindow::newWindow() {
-  auto w = new MainWindow(bookmarks);
+  auto w = new MainWindow(metricsLog, bookmarks);
   w->show();
 }
 
@@ -312,6 +354,8 @@ void MainWindow::shadingChanged(bool checked) {
 }
 
 void MainWindow::reloadBookmarks() {
+  loadBookmarksIfNeeded();
+
   // Reconstruct the bookmarks menu
   auto menu = ui->menuBookmarks_2;
   auto actions = menu->actions();
@@ -323,3 +367,9 @@ void MainWindow::reloadBookmarks() {
   for (auto &b : bookmarks->userAddedBookmarks)
     addBookmarkToMenu(b);
 }
+
+void MainWindow::saved(const QString &filename, bool ok) {
+  std::stringstream ss;
+  ss << (ok ? "Saved " : "Failed to save ") << filename.toStdString();
+  ui->statusbar->showMessage(ss.str().c_str());
+}
@@ -1,11 +1,13 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "MetricsLog.hpp"
 #include "calculation_metrics.hpp"
 #include "mandelbrot_fwd.hpp"
 #include "view_parameters.hpp"
 #include <QAction>
 #include <QActionGroup>
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QFile>
 #include <QMainWindow>
@@ -19,6 +21,7 @@ class MainWindow;
 QT_END_NAMESPACE
 
 struct SharedBookmarks {
+  bool loaded = false;
   std::vector<fractals::view_parameters> userAddedBookmarks;
   std::vector<fractals::view_parameters> builtinBookmarks;
 };
@@ -28,9 +31,11 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-  MainWindow(const std::shared_ptr<SharedBookmarks> &bookmarks = {},
+  MainWindow(const std::shared_ptr<MetricsLog> &metricsLog,
+             const std::shared_ptr<SharedBookmarks> &bookmarks = {},
              QWidget *parent = nullptr);
   ~MainWindow();
+  void setStartupTimer(const QElapsedTimer &timer);
   void closeEvent(QCloseEvent *) override;
 
 public slots:
@@ -46,12 +51,14 @@ public slots:
 
   void shadingChanged(bool checked);
   void reloadBookmarks();
+  void saved(const QString &filename, bool ok);
 
 private:
   Ui::MainWindow *ui;
   QActionGroup fractalsActionGroup;
   QActionGroup zoomSpeedActionGroup;
   QActionGroup threadingActionGroup;
+  QActionGroup compressionActionGroup;
   int initialBookmarksMenuSize;  // Used when constructing the bookmarks menu
 
   void addBookmarkToList(const fractals::view_parameters &params, bool isUser,
@@ -60,7 +67,12 @@ private:
 
   std::shared_ptr<SharedBookmarks> bookmarks;
 
+  bool firstFrameReported = false;
+
+  std::shared_ptr<MetricsLog> metricsLog;
+
   void loadBookmarks(QFile &&file, bool isUser, bool isBuiltin);
+  void loadBookmarksIfNeeded();
   void saveBookmarks();
 
   QFile getBookmarksFile();